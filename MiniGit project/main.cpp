@@ -19,8 +19,10 @@ int main(int argc, char* argv[]) {
              << "  history\n"
              << "  branch <branchname>\n"
              << "  switch <branchname>\n"
+             << "  merge <branchname>\n"
              << "  branches\n"
-             << "  diff <commit#1> <commit#2>\n";
+             << "  diff <commit#1> <commit#2>\n"
+             << "  fsck\n";
         return 1;
     }
     MiniGit git;
@@ -46,10 +48,14 @@ int main(int argc, char* argv[]) {
         git.createBranch(args[1]);
     } else if (cmd == "switch" && args.size() >= 2) {
         git.checkoutBranch(args[1]);
+    } else if (cmd == "merge" && args.size() >= 2) {
+        git.mergeBranch(args[1]);
     } else if (cmd == "branches") {
         git.printBranches();
     } else if (cmd == "diff" && args.size() >= 3) {
         git.diffCommits(stoi(args[1]), stoi(args[2]));
+    } else if (cmd == "fsck") {
+        if (!git.fsck()) return 1;
     } else {
         cout << "Invalid command or missing argument.\n";
         return 1;
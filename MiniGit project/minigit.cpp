@@ -7,6 +7,12 @@
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
+#include <map>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
 
 using namespace std;
 
@@ -119,6 +125,18 @@ void MiniGit::commit(const string& message) {
         return;
     }
 
+    // Staged entries now live in the new commit; drop them from the parent,
+    // which never stored objects for them.
+    for (FileNode **link = &commitHead->fileHead; *link;) {
+        if ((*link)->versionedFileName.empty()) {
+            FileNode* staged = *link;
+            *link = staged->next;
+            delete staged;
+        } else {
+            link = &(*link)->next;
+        }
+    }
+
     CommitNode* newCommit = new CommitNode{message, ++currentCommitNumber, newHead, commitHead};
     commitHead = newCommit;
     branches[currentBranch] = commitHead;
@@ -217,10 +235,22 @@ void MiniGit::diffCommits(int c1, int c2) {
     for (auto& [k, _] : h1) all.insert(k);
     for (auto& [k, _] : h2) all.insert(k);
 
+    vector<FileMatch> matches = detectRenames(first->fileHead, second->fileHead);
+    unordered_set<string> matched;
+    for (const auto& m : matches) {
+        matched.insert(m.to);
+        if (!m.isCopy) matched.insert(m.from);
+    }
+
     cout << "Changed files between commits " << c1 << " and " << c2 << ":";
     for (const auto& f : all) {
+        if (matched.count(f)) continue;
         if (h1[f] != h2[f]) cout << "- " << f << "";
     }
+    for (const auto& m : matches) {
+        cout << (m.isCopy ? "- copied: " : "- renamed: ") << m.from << " -> " << m.to
+             << " (" << m.similarity << "% similar)" << "";
+    }
 }
 
 void MiniGit::mergeBranch(const string& branchName) {
@@ -228,17 +258,65 @@ void MiniGit::mergeBranch(const string& branchName) {
         cout << "Branch does not exist.";
         return;
     }
+    // Staged files have no stored object yet, so they cannot go into a commit.
+    for (FileNode* f = commitHead->fileHead; f; f = f->next) {
+        if (f->versionedFileName.empty()) {
+            cout << "Commit staged changes before merging.";
+            return;
+        }
+    }
     CommitNode* other = branches[branchName];
-    unordered_map<string, string> currentFiles, otherFiles;
+    CommitNode* base = findMergeBase(commitHead, other);
+    unordered_map<string, string> currentFiles, otherFiles, baseFiles;
 
     for (FileNode* f = commitHead->fileHead; f; f = f->next)
         currentFiles[f->fileName] = f->contentHash;
+    for (FileNode* f = other->fileHead; f; f = f->next)
+        otherFiles[f->fileName] = f->contentHash;
+    if (base) {
+        for (FileNode* f = base->fileHead; f; f = f->next)
+            baseFiles[f->fileName] = f->contentHash;
+    }
+
+    // Renames are detected from the common ancestor to the other branch, so a
+    // rename made on this branch is never undone. One is applied only while
+    // this branch still has the ancestor's file unchanged.
+    unordered_set<string> renamedTo;
+    vector<FileMatch> renames;
+    if (base) {
+        for (const auto& m : detectRenames(base->fileHead, other->fileHead)) {
+            if (m.isCopy) continue;
+            renamedTo.insert(m.to);
+            if (currentFiles.count(m.to)) {
+                if (currentFiles[m.to] != otherFiles[m.to])
+                    cout << "CONFLICT: " << m.to << " was renamed from " << m.from << " in " << branchName << " but also exists here.";
+            } else if (!currentFiles.count(m.from)) {
+                cout << "CONFLICT: " << m.from << " was renamed to " << m.to << " in " << branchName << " but removed here.";
+            } else if (currentFiles[m.from] != baseFiles[m.from]) {
+                cout << "CONFLICT: " << m.from << " was renamed to " << m.to << " in " << branchName << " but modified here.";
+            } else {
+                renames.push_back(m);
+            }
+        }
+    } else {
+        for (const auto& m : detectRenames(commitHead->fileHead, other->fileHead)) {
+            if (m.isCopy) continue;
+            renamedTo.insert(m.to);
+            cout << "Possible rename " << m.from << " -> " << m.to << " not applied: no common ancestor with " << branchName << ".";
+        }
+    }
+    if (!renames.empty()) commitRenames(renames, other, branchName);
 
     for (FileNode* f = other->fileHead; f; f = f->next) {
         string fn = f->fileName;
         string otherHash = f->contentHash;
 
-        if (!currentFiles.count(fn)) {
+        if (renamedTo.count(fn)) {
+            continue;
+        } else if (base && baseFiles.count(fn) && baseFiles[fn] == otherHash) {
+            // Unchanged on the other branch since the common ancestor.
+            continue;
+        } else if (!currentFiles.count(fn)) {
             cout << "Merged new file from " << branchName << ": " << fn << "";
             addFile(fn);
         } else if (currentFiles[fn] != otherHash) {
@@ -247,6 +325,202 @@ void MiniGit::mergeBranch(const string& branchName) {
     }
 }
 
+// Moves renamed files in the working tree and records the result as a new
+// commit on the current branch, leaving existing commits untouched. The
+// renamed file takes the other branch's content, which this branch left as
+// it was in the common ancestor.
+bool MiniGit::commitRenames(const vector<FileMatch>& renames, CommitNode* other, const string& branchName) {
+    unordered_map<string, FileNode*> otherByName;
+    for (FileNode* f = other->fileHead; f; f = f->next) otherByName[f->fileName] = f;
+
+    unordered_map<string, string> applied;
+    for (const auto& m : renames) {
+        std::error_code ec;
+        std::filesystem::copy_file(otherByName[m.to]->versionedFileName, m.to,
+                                   std::filesystem::copy_options::overwrite_existing, ec);
+        if (!ec) std::filesystem::remove(m.from, ec);
+        if (ec) {
+            cerr << "Error renaming '" << m.from << "' to '" << m.to << "': " << ec.message() << endl;
+            continue;
+        }
+        applied[m.from] = m.to;
+        cout << "Merged rename from " << branchName << ": " << m.from << " -> " << m.to << "";
+    }
+    if (applied.empty()) return false;
+
+    FileNode *newHead = nullptr, *newTail = nullptr;
+    for (FileNode* f = commitHead->fileHead; f; f = f->next) {
+        FileNode* copied = new FileNode{f->fileName, f->versionedFileName, f->contentHash, nullptr};
+        if (applied.count(f->fileName)) {
+            FileNode* src = otherByName[applied[f->fileName]];
+            copied->fileName = src->fileName;
+            copied->versionedFileName = src->versionedFileName;
+            copied->contentHash = src->contentHash;
+        }
+        if (!newHead) newHead = copied;
+        else newTail->next = copied;
+        newTail = copied;
+    }
+
+    // Number past every branch, not just this one, so the new commit cannot
+    // collide with one already on the merged branch.
+    for (auto& [name, head] : branches) {
+        for (CommitNode* c = head; c; c = c->next) currentCommitNumber = max(currentCommitNumber, c->commitNumber);
+    }
+    CommitNode* newCommit = new CommitNode{"Merge renames from " + branchName, ++currentCommitNumber, newHead, commitHead};
+    commitHead = newCommit;
+    branches[currentBranch] = commitHead;
+    cout << "[" << currentBranch << "] Commit #" << currentCommitNumber << ": " << newCommit->message << "";
+    save();
+    return true;
+}
+
+// Nearest commit reachable from both a and b through parent links.
+CommitNode* MiniGit::findMergeBase(CommitNode* a, CommitNode* b) {
+    unordered_set<CommitNode*> ancestors;
+    for (CommitNode* c = b; c && ancestors.insert(c).second; c = c->next);
+    unordered_set<CommitNode*> seen;
+    for (CommitNode* c = a; c && seen.insert(c).second; c = c->next) {
+        if (ancestors.count(c)) return c;
+    }
+    return nullptr;
+}
+
+const vector<uint64_t>* MiniGit::getSketch(FileNode* f) {
+    if (f->contentHash.empty()) return nullptr;
+    auto it = sketchCache.find(f->contentHash);
+    if (it != sketchCache.end()) return &it->second;
+
+    // Sketches are keyed by content hash, so each object is only read once and
+    // the result is kept in .minigit/sketches for later runs. Files without a
+    // stored object get no sketch and are skipped.
+    string sketchPath = ".minigit/sketches/" + f->contentHash;
+    vector<uint64_t> sketch;
+    if (!readSketch(sketchPath, sketch)) {
+        string objectPath = f->versionedFileName.empty() ? ".minigit/objects/" + f->contentHash : f->versionedFileName;
+        sketch = computeFileSketch(objectPath);
+        if (sketch.empty()) return nullptr;
+        std::filesystem::create_directories(".minigit/sketches");
+        writeSketch(sketchPath, sketch);
+    }
+    return &(sketchCache[f->contentHash] = sketch);
+}
+
+vector<FileMatch> MiniGit::detectRenames(FileNode* oldFiles, FileNode* newFiles) {
+    const int RENAME_THRESHOLD = 50;
+    // 32 bands of 2 rows: a pair at exactly RENAME_THRESHOLD shares a band
+    // with probability 1 - (1 - 0.5^2)^32, about 99.9%, so banding does not
+    // drop real renames. The price is more low-similarity candidates to score.
+    const int BANDS = 32;
+    const int ROWS = SKETCH_SIZE / BANDS;
+
+    // Ordered by name so ties between equally good matches resolve the same
+    // way on every run.
+    vector<FileMatch> matches;
+    map<string, FileNode*> oldByName, newByName;
+    for (FileNode* f = oldFiles; f; f = f->next) oldByName[f->fileName] = f;
+    for (FileNode* f = newFiles; f; f = f->next) newByName[f->fileName] = f;
+
+    vector<FileNode*> added;
+    for (auto& [name, f] : newByName) {
+        if (!oldByName.count(name)) added.push_back(f);
+    }
+    if (added.empty()) return matches;
+
+    // Any old file may be the source of a copy; only deleted ones can be renamed.
+    vector<FileNode*> sources;
+    unordered_set<string> deleted;
+    unordered_map<string, vector<FileNode*>> deletedByHash;
+    unordered_map<string, FileNode*> oldByHash;
+    for (auto& [name, f] : oldByName) {
+        sources.push_back(f);
+        if (!newByName.count(name)) deleted.insert(name);
+        if (f->contentHash.empty()) continue;
+        oldByHash.emplace(f->contentHash, f);
+        if (!newByName.count(name)) deletedByHash[f->contentHash].push_back(f);
+    }
+
+    // Exact renames and copies share a content hash.
+    unordered_set<string> usedSources;
+    vector<FileNode*> unmatched;
+    for (FileNode* a : added) {
+        if (a->contentHash.empty()) continue;
+        auto it = deletedByHash.find(a->contentHash);
+        if (it != deletedByHash.end() && !it->second.empty()) {
+            FileNode* src = it->second.front();
+            it->second.erase(it->second.begin());
+            usedSources.insert(src->fileName);
+            matches.push_back({src->fileName, a->fileName, 100, false});
+        } else if (oldByHash.count(a->contentHash)) {
+            matches.push_back({oldByHash[a->contentHash]->fileName, a->fileName, 100, true});
+        } else {
+            unmatched.push_back(a);
+        }
+    }
+    if (unmatched.empty() || sources.empty()) return matches;
+
+    // Near matches: bucket sources by bands of their sketch so each added file
+    // is only scored against sources that share at least one band.
+    auto bandKey = [&](const vector<uint64_t>& sketch, int band) {
+        uint64_t key = band;
+        for (int r = 0; r < ROWS; ++r) {
+            key = (key ^ sketch[band * ROWS + r]) * 0x100000001b3ULL;
+        }
+        return key;
+    };
+    vector<unordered_map<uint64_t, vector<int>>> buckets(BANDS);
+    for (int i = 0; i < (int)sources.size(); ++i) {
+        const vector<uint64_t>* sketch = getSketch(sources[i]);
+        if (!sketch) continue;
+        for (int b = 0; b < BANDS; ++b) buckets[b][bandKey(*sketch, b)].push_back(i);
+    }
+
+    struct Candidate {
+        int similarity;
+        int added;
+        int source;
+    };
+    vector<Candidate> candidates;
+    for (int a = 0; a < (int)unmatched.size(); ++a) {
+        const vector<uint64_t>* sketch = getSketch(unmatched[a]);
+        if (!sketch) continue;
+        unordered_set<int> seen;
+        for (int b = 0; b < BANDS; ++b) {
+            auto it = buckets[b].find(bandKey(*sketch, b));
+            if (it == buckets[b].end()) continue;
+            for (int s : it->second) {
+                if (!seen.insert(s).second) continue;
+                // Equal sketches do not mean equal content; 100 is reserved
+                // for matching hashes.
+                int sim = min(99, sketchSimilarity(*sketch, *getSketch(sources[s])));
+                if (sim >= RENAME_THRESHOLD) candidates.push_back({sim, a, s});
+            }
+        }
+    }
+    stable_sort(candidates.begin(), candidates.end(), [](const Candidate& x, const Candidate& y) {
+        if (x.similarity != y.similarity) return x.similarity > y.similarity;
+        if (x.added != y.added) return x.added < y.added;
+        return x.source < y.source;
+    });
+
+    // Best pairs win; renames are assigned before copies so a deleted file is
+    // not reported as copied when it was really moved.
+    vector<bool> done(unmatched.size(), false);
+    for (const auto& c : candidates) {
+        const string& from = sources[c.source]->fileName;
+        if (done[c.added] || !deleted.count(from) || usedSources.count(from)) continue;
+        done[c.added] = true;
+        usedSources.insert(from);
+        matches.push_back({from, unmatched[c.added]->fileName, c.similarity, false});
+    }
+    for (const auto& c : candidates) {
+        if (done[c.added]) continue;
+        done[c.added] = true;
+        matches.push_back({sources[c.source]->fileName, unmatched[c.added]->fileName, c.similarity, true});
+    }
+    return matches;
+}
+
 
 void MiniGit::save() {
     std::filesystem::create_directories(".minigit/meta");
@@ -268,6 +542,7 @@ void MiniGit::save() {
             if (seen.count(c->commitNumber)) continue;
             seen.insert(c->commitNumber);
             commitsFile << c->commitNumber << "|" << c->message << std::endl;
+            if (c->next) commitsFile << "P|" << c->next->commitNumber << std::endl;
             for (FileNode* f = c->fileHead; f; f = f->next) {
                 commitsFile << "F|" << f->fileName << "|" << f->versionedFileName << "|" << f->contentHash << std::endl;
             }
@@ -324,15 +599,29 @@ void MiniGit::load() {
     // Load commits
     std::ifstream commitsFile(".minigit/meta/commits.txt");
     std::unordered_map<int, CommitNode*> prevMap;
+    std::vector<std::pair<CommitNode*, int>> parents;
     if (commitsFile) {
         std::string line;
         CommitNode* last = nullptr;
         while (std::getline(commitsFile, line)) {
             if (line.empty()) continue;
-            if (line.find('|') != std::string::npos && line.substr(0, 1) != "F") {
+            if (line.substr(0, 2) == "P|") {
+                // Parent line
+                try {
+                    if (last) parents.push_back({last, std::stoi(line.substr(2))});
+                } catch (const std::exception&) {
+                }
+            } else if (line.find('|') != std::string::npos && line.substr(0, 1) != "F") {
                 // Commit line
                 size_t bar = line.find('|');
-                int num = std::stoi(line.substr(0, bar));
+                int num;
+                try {
+                    num = std::stoi(line.substr(0, bar));
+                } catch (const std::exception&) {
+                    // Corrupt commit line; fsck reports it.
+                    last = nullptr;
+                    continue;
+                }
                 std::string msg = line.substr(bar + 1);
                 CommitNode* c = new CommitNode{msg, num, nullptr, nullptr};
                 commitMap[num] = c;
@@ -346,18 +635,22 @@ void MiniGit::load() {
                 std::getline(iss, fname, '|');
                 std::getline(iss, vfname, '|');
                 std::getline(iss, hash, '|');
-                if (vfname.empty()) vfname = ".minigit/objects/" + hash;
+                // Skipped when the commit line above it was corrupt.
+                if (!last) continue;
+                // An empty object path marks a file staged but not committed.
                 FileNode* f = new FileNode{fname, vfname, hash, nullptr};
-                if (last) {
-                    f->next = last->fileHead;
-                    last->fileHead = f;
-                }
+                f->next = last->fileHead;
+                last->fileHead = f;
             } else if (line == "ENDC") {
                 last = nullptr;
             }
         }
         commitsFile.close();
     }
+    // Relink parents
+    for (auto& [c, parent] : parents) {
+        if (commitMap.count(parent) && commitMap[parent] != c) c->next = commitMap[parent];
+    }
     // Rebuild branches
     for (auto& [name, num] : branchPairs) {
         if (commitMap.count(num)) {
@@ -380,3 +673,179 @@ void MiniGit::init() {
     createMinigitDirectory();
     std::cout << "Initialized empty MiniGit repository in .minigit/\n";
 }
+
+bool MiniGit::fsck() {
+    int errors = 0;
+    auto report = [&](const string& msg) {
+        cout << "error: " << msg << endl;
+        errors++;
+    };
+
+    // Read the metadata directly: load() skips lines it cannot parse, which is
+    // exactly what needs reporting here.
+    struct FileRef {
+        int commitNumber;
+        string fileName;
+        string path;
+        string hash;
+    };
+    vector<FileRef> refs;
+    int staged = 0;
+    vector<pair<int, int>> parents;
+    unordered_set<int> commitNumbers;
+    ifstream commitsFile(".minigit/meta/commits.txt");
+    if (commitsFile) {
+        string line;
+        int lineNo = 0;
+        int current = -1;
+        while (getline(commitsFile, line)) {
+            lineNo++;
+            if (line.empty()) continue;
+            string where = "commits.txt:" + to_string(lineNo);
+            if (line == "ENDC") {
+                if (current < 0) report(where + ": ENDC outside of a commit");
+                current = -1;
+            } else if (line.substr(0, 2) == "P|") {
+                string num = line.substr(2);
+                if (current < 0) {
+                    report(where + ": parent entry outside of a commit");
+                } else if (num.empty() || num.size() > 9 || num.find_first_not_of("0123456789") != string::npos) {
+                    report(where + ": corrupt parent entry");
+                } else {
+                    parents.push_back({current, stoi(num)});
+                }
+            } else if (line.substr(0, 2) == "F|") {
+                istringstream iss(line.substr(2));
+                string fname, vfname, hash;
+                getline(iss, fname, '|');
+                getline(iss, vfname, '|');
+                getline(iss, hash, '|');
+                if (current < 0) {
+                    report(where + ": file entry outside of a commit");
+                } else if (fname.empty() || hash.size() != 40 ||
+                           hash.find_first_not_of("0123456789abcdef") != string::npos) {
+                    report(where + ": corrupt file entry");
+                } else if (vfname.empty()) {
+                    // Staged with add but not committed yet: no object to check.
+                    staged++;
+                } else {
+                    refs.push_back({current, fname, vfname, hash});
+                }
+            } else {
+                size_t bar = line.find('|');
+                string num = line.substr(0, bar);
+                if (bar == string::npos || num.empty() || num.find_first_not_of("0123456789") != string::npos) {
+                    report(where + ": corrupt commit line");
+                    current = -1;
+                    continue;
+                }
+                if (current >= 0) report(where + ": commit #" + to_string(current) + " is missing ENDC");
+                try {
+                    current = stoi(num);
+                } catch (const std::out_of_range&) {
+                    report(where + ": corrupt commit line");
+                    current = -1;
+                    continue;
+                }
+                if (!commitNumbers.insert(current).second) {
+                    report(where + ": duplicate commit #" + num);
+                }
+            }
+        }
+        if (current >= 0) report("commits.txt: commit #" + to_string(current) + " is missing ENDC");
+    }
+
+    for (const auto& [commit, parent] : parents) {
+        if (!commitNumbers.count(parent)) {
+            report("commit #" + to_string(commit) + " has missing parent #" + to_string(parent));
+        }
+    }
+
+    // Branch refs must point at commits that exist, and HEAD at a branch.
+    unordered_set<string> branchNames;
+    ifstream branchesFile(".minigit/meta/branches.txt");
+    if (branchesFile) {
+        string line;
+        int lineNo = 0;
+        while (getline(branchesFile, line)) {
+            lineNo++;
+            if (line.empty()) continue;
+            istringstream iss(line);
+            string name, extra;
+            int num;
+            if (!(iss >> name >> num) || (iss >> extra)) {
+                report("branches.txt:" + to_string(lineNo) + ": corrupt branch ref");
+            } else if (!commitNumbers.count(num)) {
+                report("branch '" + name + "' points to missing commit #" + to_string(num));
+            } else {
+                branchNames.insert(name);
+            }
+        }
+    }
+    ifstream headFile(".minigit/meta/HEAD.txt");
+    string head;
+    if (headFile && getline(headFile, head) && !branchNames.count(head)) {
+        report("HEAD points to unknown branch '" + head + "'");
+    }
+
+    // Every stored object plus every path a commit refers to gets rehashed once.
+    vector<string> paths;
+    unordered_map<string, size_t> pathIndex;
+    auto addPath = [&](const string& path) {
+        if (pathIndex.emplace(path, paths.size()).second) paths.push_back(path);
+    };
+    if (std::filesystem::exists(".minigit/objects")) {
+        for (const auto& entry : std::filesystem::directory_iterator(".minigit/objects")) {
+            if (entry.is_regular_file()) addPath(".minigit/objects/" + entry.path().filename().string());
+        }
+    }
+    size_t storedObjects = paths.size();
+    for (const auto& r : refs) addPath(r.path);
+
+    // Hashing is I/O bound, so workers pull paths off a shared counter to keep
+    // every thread busy regardless of object size.
+    vector<string> hashes(paths.size());
+    atomic<size_t> nextPath{0};
+    atomic<uint64_t> totalBytes{0};
+    unsigned workers = max(4u, thread::hardware_concurrency());
+    workers = min<unsigned>(workers, max<size_t>(1, paths.size()));
+    auto start = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (unsigned i = 0; i < workers; ++i) {
+        pool.emplace_back([&]() {
+            vector<char> buf(1 << 20);
+            for (size_t p = nextPath++; p < paths.size(); p = nextPath++) {
+                uint64_t bytes = 0;
+                hashes[p] = computeFileHashStreamed(paths[p], buf, bytes);
+                totalBytes += bytes;
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    const string objectPrefix = ".minigit/objects/";
+    for (size_t p = 0; p < storedObjects; ++p) {
+        string name = paths[p].substr(objectPrefix.size());
+        if (hashes[p].empty()) report("object " + name + " could not be read");
+        else if (name != hashes[p]) report("object " + name + " is corrupt (hashes to " + hashes[p] + ")");
+    }
+    for (const auto& r : refs) {
+        const string& actual = hashes[pathIndex[r.path]];
+        string where = "commit #" + to_string(r.commitNumber) + ": " + r.fileName;
+        if (actual.empty()) {
+            report(where + " references missing object " + r.path);
+        } else if (actual != r.hash) {
+            report(where + " expects " + r.hash + " but " + r.path + " hashes to " + actual);
+        }
+    }
+
+    double mb = totalBytes / (1024.0 * 1024.0);
+    cout << "Checked " << paths.size() << " objects (" << fixed << setprecision(1) << mb << " MB) in "
+         << seconds << "s using " << workers << " threads";
+    if (seconds > 0) cout << " (" << mb / seconds << " MB/s)";
+    cout << "." << endl;
+    cout << commitNumbers.size() << " commits, " << refs.size() << " file references, " << staged << " staged, "
+         << branchNames.size() << " branches: " << errors << (errors == 1 ? " error." : " errors.") << endl;
+    return errors == 0;
+}
@@ -3,6 +3,8 @@
 
 #include <unordered_map>
 #include <string>
+#include <vector>
+#include <cstdint>
 #include "utils.hpp"
 
 using namespace std;
@@ -21,6 +23,16 @@ struct CommitNode {
     CommitNode* next;
 };
 
+// A file in a newer tree that was detected as a rename or copy of a file in an
+// older tree. similarity is 100 only when the content hashes are equal;
+// sketch-based estimates are capped at 99.
+struct FileMatch {
+    string from;
+    string to;
+    int similarity;
+    bool isCopy;
+};
+
 class MiniGit {
 private:
     CommitNode* commitHead;
@@ -28,9 +40,16 @@ private:
     unordered_map<string, CommitNode*> branches;
     string currentBranch;
 
+    unordered_map<string, vector<uint64_t>> sketchCache;
+
     void save();
     void load();
 
+    const vector<uint64_t>* getSketch(FileNode* f);
+    vector<FileMatch> detectRenames(FileNode* oldFiles, FileNode* newFiles);
+    CommitNode* findMergeBase(CommitNode* a, CommitNode* b);
+    bool commitRenames(const vector<FileMatch>& renames, CommitNode* other, const string& branchName);
+
 public:
     MiniGit();
 
@@ -50,6 +69,8 @@ public:
     
     void createBranch(const string& name);
     void checkoutBranch(const string& name);
+
+    bool fsck();
 };
 
 
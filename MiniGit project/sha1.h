@@ -3,6 +3,7 @@
 #include <sstream>
 #include <iomanip>
 #include <cstring>
+#include <algorithm>
 #include <cstdint>]
 
 class SHA1 {
@@ -14,14 +15,26 @@ public:
     }
 
     void update(const uint8_t* data, size_t len) {
-        for (size_t i = 0; i < len; ++i) {
-            m_block[m_blockByteIndex++] = data[i];
-            m_byteCount++;
-            if (m_blockByteIndex == 64) {
-                processBlock();
-                m_blockByteIndex = 0;
-            }
+        m_byteCount += len;
+        // Top up a partially filled block first, then hash whole blocks
+        // straight from the input and buffer whatever is left over.
+        if (m_blockByteIndex > 0) {
+            size_t n = std::min(len, size_t(64) - m_blockByteIndex);
+            std::memcpy(m_block + m_blockByteIndex, data, n);
+            m_blockByteIndex += n;
+            data += n;
+            len -= n;
+            if (m_blockByteIndex < 64) return;
+            processBlock(m_block);
+            m_blockByteIndex = 0;
+        }
+        while (len >= 64) {
+            processBlock(data);
+            data += 64;
+            len -= 64;
         }
+        std::memcpy(m_block, data, len);
+        m_blockByteIndex = len;
     }
 
     std::string final() {
@@ -59,13 +72,13 @@ private:
         m_byteCount = 0;
     }
 
-    void processBlock() {
+    void processBlock(const uint8_t* block) {
         uint32_t w[80];
         for (int i = 0; i < 16; ++i) {
-            w[i] = (m_block[i * 4 + 0] << 24) |
-                   (m_block[i * 4 + 1] << 16) |
-                   (m_block[i * 4 + 2] << 8) |
-                   (m_block[i * 4 + 3]);
+            w[i] = (uint32_t(block[i * 4 + 0]) << 24) |
+                   (block[i * 4 + 1] << 16) |
+                   (block[i * 4 + 2] << 8) |
+                   (block[i * 4 + 3]);
         }
         for (int i = 16; i < 80; ++i) {
             w[i] = leftrotate(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
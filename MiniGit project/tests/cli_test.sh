@@ -0,0 +1,210 @@
+#!/usr/bin/env bash
+# Runs the minigit CLI against scripted repositories and checks its output.
+# Usage: tests/cli_test.sh <path-to-minigit-binary>
+
+BIN="$(realpath "${1:?usage: $0 <path-to-minigit-binary>}")"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+failures=0
+
+# Starts a fresh repository in its own directory with hand-written metadata.
+new_repo() {
+    cd "$WORK" && rm -rf repo && mkdir -p repo/.minigit/objects repo/.minigit/meta && cd repo
+    echo main > .minigit/meta/HEAD.txt
+    : > .minigit/meta/commits.txt
+    : > .minigit/meta/branches.txt
+}
+
+# Stores a file as an object and prints its hash.
+store() {
+    local hash
+    hash="$(sha1sum "$1" | cut -c1-40)"
+    cp "$1" ".minigit/objects/$hash"
+    echo "$hash"
+}
+
+# commit <number> <parent or -> <name>=<hash>...
+commit() {
+    local num="$1" parent="$2"
+    shift 2
+    echo "$num|commit $num" >> .minigit/meta/commits.txt
+    [ "$parent" != "-" ] && echo "P|$parent" >> .minigit/meta/commits.txt
+    for entry in "$@"; do
+        local hash="${entry#*=}"
+        echo "F|${entry%%=*}|.minigit/objects/$hash|$hash" >> .minigit/meta/commits.txt
+    done
+    echo "ENDC" >> .minigit/meta/commits.txt
+}
+
+branch() {
+    echo "$1 $2" >> .minigit/meta/branches.txt
+}
+
+check() {
+    local name="$1" output="$2" pattern="$3"
+    if grep -qE -- "$pattern" <<< "$output"; then
+        echo "ok   $name"
+    else
+        echo "FAIL $name: expected /$pattern/ in:"
+        echo "$output"
+        failures=$((failures + 1))
+    fi
+}
+
+check_not() {
+    local name="$1" output="$2" pattern="$3"
+    if grep -qE -- "$pattern" <<< "$output"; then
+        echo "FAIL $name: unexpected /$pattern/ in:"
+        echo "$output"
+        failures=$((failures + 1))
+    else
+        echo "ok   $name"
+    fi
+}
+
+# --- rename and copy detection ---
+
+new_repo
+seq 1 5000 > a.txt
+ha="$(store a.txt)"
+commit 1 - "a.txt=$ha"
+commit 2 1 "b.txt=$ha"
+branch main 1
+branch feature 2
+out="$("$BIN" diff 1 2)"
+check "exact rename" "$out" "renamed: a\.txt -> b\.txt \(100% similar\)"
+
+new_repo
+seq 1 5000 > a.txt
+{ seq 1 5000; echo "one more line"; } > b.txt
+commit 1 - "a.txt=$(store a.txt)"
+commit 2 1 "b.txt=$(store b.txt)"
+branch main 1
+branch feature 2
+out="$("$BIN" diff 1 2)"
+check "near rename" "$out" "renamed: a\.txt -> b\.txt \(9[0-9]% similar\)"
+
+new_repo
+seq 1 5000 > a.txt
+ha="$(store a.txt)"
+commit 1 - "a.txt=$ha"
+commit 2 1 "a.txt=$ha" "c.txt=$ha"
+branch main 1
+branch feature 2
+out="$("$BIN" diff 1 2)"
+check "exact copy" "$out" "copied: a\.txt -> c\.txt \(100% similar\)"
+
+new_repo
+seq 1 1000 > a.txt
+{ seq 1 900; seq 20001 20100; } > b.txt
+seq 1 200 > c.txt
+seq 30001 30800 >> c.txt
+commit 1 - "a.txt=$(store a.txt)" "x.txt=$(store c.txt)"
+commit 2 1 "b.txt=$(store b.txt)"
+branch main 1
+branch feature 2
+out="$("$BIN" diff 1 2)"
+check "above threshold is a rename" "$out" "renamed: a\.txt -> b\.txt"
+check_not "below threshold is not a rename" "$out" "x\.txt ->"
+
+# --- merge ---
+
+new_repo
+seq 1 5000 > a.txt
+echo extra > x.txt
+ha="$(store a.txt)"
+hx="$(store x.txt)"
+commit 1 - "a.txt=$ha"
+commit 2 1 "a.txt=$ha" "x.txt=$hx"
+commit 3 1 "b.txt=$ha"
+branch main 2
+branch feature 3
+out="$("$BIN" merge feature)"
+check "merge applies rename from ancestor" "$out" "Merged rename from feature: a\.txt -> b\.txt"
+check "merge rename moves the file" "$(ls)" "^b\.txt$"
+check_not "merge rename removes the old file" "$(ls)" "^a\.txt$"
+check "merge rename keeps history" "$(sed -n '/^1|/,/^ENDC/p' .minigit/meta/commits.txt)" "^F\|a\.txt\|"
+
+new_repo
+seq 1 5000 > b.txt
+hb="$(store b.txt)"
+commit 1 - "a.txt=$hb"
+commit 2 1 "b.txt=$hb"
+branch main 2
+branch feature 1
+out="$("$BIN" merge feature)"
+check_not "merge keeps this branch's rename" "$out" "rename|CONFLICT"
+check "merge leaves the working tree alone" "$(ls)" "^b\.txt$"
+check_not "merge makes no commit when behind" "$(cat .minigit/meta/branches.txt)" "main 3"
+
+new_repo
+seq 1 5000 > a.txt
+ha="$(store a.txt)"
+commit 1 - "a.txt=$ha"
+commit 2 - "b.txt=$ha"
+branch main 1
+branch feature 2
+out="$("$BIN" merge feature)"
+check "merge without ancestor only reports" "$out" "not applied: no common ancestor"
+check "merge without ancestor leaves the file" "$(ls)" "^a\.txt$"
+
+# --- fsck ---
+
+cd "$WORK" && rm -rf repo && mkdir repo && cd repo
+echo one > c.txt
+"$BIN" add c.txt > /dev/null
+echo two > c.txt
+"$BIN" commit -m two > /dev/null
+echo three > d.txt
+"$BIN" add d.txt > /dev/null
+out="$("$BIN" fsck)"
+status=$?
+check "fsck passes after add, edit, commit" "$out" " 0 errors\.$"
+check "fsck exit status on a healthy repo" "$status" "^0$"
+check "fsck counts staged files" "$out" " 1 staged"
+
+new_repo
+seq 1 5000 > a.txt
+ha="$(store a.txt)"
+commit 1 - "a.txt=$ha"
+branch main 1
+truncate -s 10 ".minigit/objects/$ha"
+out="$("$BIN" fsck)"
+status=$?
+check "fsck finds a truncated object" "$out" "object $ha is corrupt"
+check "fsck finds a reference to a corrupt object" "$out" "commit #1: a\.txt expects $ha"
+check "fsck exit status on errors" "$status" "^1$"
+
+new_repo
+seq 1 5000 > a.txt
+ha="$(store a.txt)"
+rm ".minigit/objects/$ha"
+commit 1 - "a.txt=$ha"
+branch main 1
+out="$("$BIN" fsck)"
+check "fsck finds a missing object" "$out" "commit #1: a\.txt references missing object"
+
+new_repo
+seq 1 5000 > a.txt
+commit 1 - "a.txt=$(store a.txt)"
+commit 2 7 "a.txt=$(store a.txt)"
+echo "99999999999999|x" >> .minigit/meta/commits.txt
+echo "F|a.txt|.minigit/objects/zz|zz" >> .minigit/meta/commits.txt
+echo "ENDC" >> .minigit/meta/commits.txt
+branch main 1
+branch ghost 9
+echo gone > .minigit/meta/HEAD.txt
+out="$("$BIN" fsck)"
+status=$?
+check "fsck reports an overflowing commit number" "$out" "commits\.txt:8: corrupt commit line"
+check "fsck reports a file entry outside a commit" "$out" "commits\.txt:9: file entry outside of a commit"
+check "fsck reports a missing parent" "$out" "commit #2 has missing parent #7"
+check "fsck reports a branch to a missing commit" "$out" "branch 'ghost' points to missing commit #9"
+check "fsck reports an unknown HEAD" "$out" "HEAD points to unknown branch 'gone'"
+check "fsck does not abort on corrupt metadata" "$status" "^1$"
+
+if [ "$failures" -ne 0 ]; then
+    echo "$failures check(s) failed."
+    exit 1
+fi
+echo "All checks passed."
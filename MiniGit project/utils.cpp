@@ -50,6 +50,22 @@ string computeFileHash(const string& filename) {
     return SHA1::from_string(content);
 }
 
+// Hashes the file through buf so large objects are never held in memory.
+// Callers reuse buf across files to avoid reallocating it per object.
+string computeFileHashStreamed(const string& filename, vector<char>& buf, uint64_t& bytesRead) {
+    bytesRead = 0;
+    ifstream file(filename, ios::binary);
+    if (!file.is_open()) return "";
+    SHA1 sha1;
+    while (file.read(buf.data(), buf.size()) || file.gcount() > 0) {
+        streamsize n = file.gcount();
+        sha1.update(reinterpret_cast<const uint8_t*>(buf.data()), n);
+        bytesRead += n;
+    }
+    if (file.bad()) return "";
+    return sha1.final();
+}
+
 void copyFile(const std::string& src, const std::string& dest) {
     try {
         std::filesystem::copy_file(src, dest, std::filesystem::copy_options::overwrite_existing);
@@ -58,6 +74,72 @@ void copyFile(const std::string& src, const std::string& dest) {
     }
 }
 
+// 64-bit mixer (splitmix64 finalizer) used to derive the MinHash permutations.
+static uint64_t mixHash(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+vector<uint64_t> computeFileSketch(const string& filename) {
+    ifstream file(filename, ios::binary);
+    if (!file.is_open()) return {};
+    vector<uint64_t> sketch(SKETCH_SIZE, UINT64_MAX);
+
+    // Split the content into chunks ending at a newline (or every 64 bytes for
+    // long lines and binary data) and fingerprint each chunk with FNV-1a.
+    const uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+    const uint64_t FNV_PRIME = 0x100000001b3ULL;
+    uint64_t fp = FNV_OFFSET;
+    size_t chunkLen = 0;
+    auto addChunk = [&]() {
+        for (int i = 0; i < SKETCH_SIZE; ++i) {
+            uint64_t h = mixHash(fp ^ mixHash(i + 1));
+            if (h < sketch[i]) sketch[i] = h;
+        }
+        fp = FNV_OFFSET;
+        chunkLen = 0;
+    };
+
+    char buf[65536];
+    while (file.read(buf, sizeof(buf)) || file.gcount() > 0) {
+        streamsize n = file.gcount();
+        for (streamsize i = 0; i < n; ++i) {
+            fp = (fp ^ static_cast<unsigned char>(buf[i])) * FNV_PRIME;
+            if (++chunkLen == 64 || buf[i] == '\n') addChunk();
+        }
+    }
+    if (chunkLen > 0) addChunk();
+    return sketch;
+}
+
+// Estimated percentage of shared chunks between two files.
+int sketchSimilarity(const vector<uint64_t>& a, const vector<uint64_t>& b) {
+    if (a.size() != b.size() || a.empty()) return 0;
+    int same = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i] == b[i]) same++;
+    }
+    return same * 100 / static_cast<int>(a.size());
+}
+
+bool readSketch(const string& path, vector<uint64_t>& sketch) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) return false;
+    sketch.assign(SKETCH_SIZE, 0);
+    file.read(reinterpret_cast<char*>(sketch.data()), SKETCH_SIZE * sizeof(uint64_t));
+    return file.gcount() == static_cast<streamsize>(SKETCH_SIZE * sizeof(uint64_t));
+}
+
+void writeSketch(const string& path, const vector<uint64_t>& sketch) {
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open()) return;
+    file.write(reinterpret_cast<const char*>(sketch.data()), sketch.size() * sizeof(uint64_t));
+}
+
 
 
 
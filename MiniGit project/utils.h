@@ -1,12 +1,23 @@
 #ifndef UTILS_HPP_INCLUDED 
 #define UTILS_HPP_INCLUDED 
 #include <string> 
+#include <vector>
+#include <cstdint>
 
 bool fileExists(const std::string& filename);
 bool filesAreEqual(const std::string& file1, const std::string& file2);
 void createMinigitDirectory(); 
 std::string generateVersionedFilename(std::string filename, int version);
 std::string computeFileHash(const std::string& filename);
+std::string computeFileHashStreamed(const std::string& filename, std::vector<char>& buf, uint64_t& bytesRead);
 void copyFile(const std::string& src, const std::string& dest);
 
+// MinHash sketch of a file's chunk fingerprints, used to estimate how similar
+// two files are without comparing their full contents. Empty if unreadable.
+const int SKETCH_SIZE = 64;
+std::vector<uint64_t> computeFileSketch(const std::string& filename);
+int sketchSimilarity(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b);
+bool readSketch(const std::string& path, std::vector<uint64_t>& sketch);
+void writeSketch(const std::string& path, const std::vector<uint64_t>& sketch);
+
 #endif